@@ -0,0 +1,1514 @@
+// Benchmark of the create and update flows on synthetic working trees.
+// GitHub is replaced by local stand-ins: a stub "gh" script on PATH and bare
+// repositories reached through a url.insteadOf rule, so runs need no network
+// and numbers can be compared across commits.
+//
+//   github_automation_benchmark [--sizes 1000,10000,100000] [--runs N]
+//                               [--output FILE] [--work-dir DIR] [--seed N] [--keep]
+//                               [--api-repos N] [--api-limit N] [--api-window S] [--api-writes N]
+//                               [--ignored-files N]
+
+#define GITHUB_AUTOMATION_NO_MAIN
+#include "main.cpp"
+
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <set>
+#include <random>
+
+#ifdef _WIN32
+int main() {
+    std::cout << "The benchmark needs a POSIX shell for its gh stand-in." << std::endl;
+    return 2;
+}
+#else
+
+// Settings of one benchmark run
+struct BenchmarkOptions {
+    std::vector<size_t> sizes = {1000, 10000};
+    int runs = 3;
+    std::string outputPath = "benchmark_results.json";
+    std::string workDir;     // Empty: a fresh directory under the system temp directory
+    unsigned seed = 20240601;
+    bool keepWorkDir = false;
+    int apiRepos = 40;           // Repositories created against the rate-limited mock API (0: skip)
+    int apiLimit = 60;           // Mock primary limit: calls per window
+    int apiWindowSeconds = 5;
+    int apiWritesPerSecond = 10; // Mock secondary limit
+    size_t ignoredFiles = 50000; // Files under the ignored node_modules/ of the listing scenario (0: skip)
+};
+
+// Shape of a generated working tree
+struct SyntheticTreeStats {
+    size_t files = 0;
+    size_t directories = 0;
+    size_t binaryFiles = 0;
+    unsigned long long bytes = 0;
+};
+
+// Measurements of one scenario run
+struct ScenarioSample {
+    double totalMs = 0.0;
+    std::map<std::string, double> stepMs;  // Summed duration of each traced step
+    size_t processes = 0;                  // Child processes started
+    bool success = false;
+};
+
+// Collects what a flow prints; repository creation writes from its own thread
+class CapturedOutput : public std::streambuf {
+public:
+    std::string text() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return text_;
+    }
+    
+protected:
+    // No put area, so every character comes through here under the lock
+    int_type overflow(int_type c) override {
+        if (c != traits_type::eof()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            text_ += traits_type::to_char_type(c);
+        }
+        return c;
+    }
+    
+    std::streamsize xsputn(const char* data, std::streamsize size) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        text_.append(data, static_cast<size_t>(size));
+        return size;
+    }
+    
+private:
+    std::mutex mutex_;
+    std::string text_;
+};
+
+// Write a file of the given size; binary files get incompressible bytes
+void writeSyntheticFile(const fs::path& path, size_t size, bool binary, std::mt19937& random) {
+    std::string content;
+    content.reserve(size);
+    if (binary) {
+        while (content.size() < size) {
+            uint32_t value = random();
+            content.append(reinterpret_cast<const char*>(&value), std::min<size_t>(4, size - content.size()));
+        }
+    } else {
+        static const char* words[] = {"alpha", "beta", "gamma", "delta", "value", "return", "struct", "index"};
+        while (content.size() < size) {
+            content += words[random() % 8];
+            content += (random() % 12 == 0) ? '\n' : ' ';
+        }
+        content.resize(size);
+    }
+    std::ofstream out(path, std::ios::binary);
+    out.write(content.data(), static_cast<std::streamsize>(content.size()));
+}
+
+// Generate a deterministic tree of fileCount files: directories nested up to
+// six levels, mostly small text files with a few larger binaries
+SyntheticTreeStats generateSyntheticTree(const fs::path& root, size_t fileCount, unsigned seed) {
+    std::mt19937 random(seed);
+    SyntheticTreeStats stats;
+    
+    // About 20 files per directory, spread over depths 0..6
+    std::vector<fs::path> directories = {root};
+    std::vector<int> depths = {0};
+    size_t directoryCount = std::max<size_t>(1, fileCount / 20);
+    for (size_t i = 1; i < directoryCount; ++i) {
+        size_t parent = random() % directories.size();
+        if (depths[parent] >= 6) {
+            parent = 0;
+        }
+        directories.push_back(directories[parent] / ("dir" + std::to_string(i)));
+        depths.push_back(depths[parent] + 1);
+    }
+    for (const auto& directory : directories) {
+        fs::create_directories(directory);
+    }
+    stats.directories = directories.size();
+    
+    for (size_t i = 0; i < fileCount; ++i) {
+        const fs::path& directory = directories[random() % directories.size()];
+        unsigned kind = random() % 100;
+        bool binary = kind == 0;  // 1%: 32 KiB .. 256 KiB binaries
+        size_t size = binary ? 32768 + random() % 229376
+                    : kind < 10 ? 8192 + random() % 57344  // 9%: 8 KiB .. 64 KiB text
+                    : 64 + random() % 4032;                  // 90%: small source-like files
+        fs::path path = directory / ("file" + std::to_string(i) + (binary ? ".bin" : ".txt"));
+        writeSyntheticFile(path, size, binary, random);
+        stats.files++;
+        stats.binaryFiles += binary ? 1 : 0;
+        stats.bytes += size;
+    }
+    return stats;
+}
+
+// Change a deterministic subset of a tree: modify 5%, delete 1% and add 2% files
+void mutateSyntheticTree(const fs::path& root, unsigned seed) {
+    std::mt19937 random(seed);
+    std::vector<fs::path> files;
+    for (auto it = fs::recursive_directory_iterator(root); it != fs::recursive_directory_iterator(); ++it) {
+        if (it->is_directory() && it->path().filename() == ".git") {
+            it.disable_recursion_pending();
+        } else if (it->is_regular_file()) {
+            files.push_back(it->path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    
+    size_t count = files.size();
+    for (size_t i = 0; i < count / 20; ++i) {
+        std::ofstream out(files[random() % count], std::ios::app);
+        out << "changed " << i << "\n";
+    }
+    for (size_t i = 0; i < count / 100; ++i) {
+        std::error_code ec;
+        fs::remove(files[random() % count], ec);
+    }
+    for (size_t i = 0; i < count / 50; ++i) {
+        fs::path directory = files[random() % count].parent_path();
+        writeSyntheticFile(directory / ("added" + std::to_string(i) + ".txt"), 64 + random() % 4032, false, random);
+    }
+}
+
+// Install the stub gh, the git configuration and an isolated HOME in the sandbox
+bool installStandIns(const fs::path& sandbox) {
+    fs::create_directories(sandbox / "bin");
+    fs::create_directories(sandbox / "remotes");
+    fs::create_directories(sandbox / "home");
+    
+    fs::path ghPath = sandbox / "bin" / "gh";
+    std::ofstream gh(ghPath);
+    gh << "#!/bin/sh\n"
+       << "# Stand-in for the GitHub CLI used by github_automation_benchmark\n"
+       << "case \"$1 $2\" in\n"
+       << "  \"api user\") printf 'HTTP/2.0 200 OK\\r\\nX-Oauth-Scopes: repo, read:org\\r\\n\\r\\n"
+       << "{\"login\":\"bench\",\"id\":1}' ;;\n"
+       << "  \"auth status\") echo \"Logged in to github.com account bench\" ;;\n"
+       << "  \"--version \") echo \"gh version 0.0.0 (benchmark stub)\" ;;\n"
+       << "  \"repo create\") case \"$3\" in fail-*) echo \"GraphQL: Name already exists on this account\" >&2; exit 1 ;; esac\n"
+       << "    remote=\"" << (sandbox / "remotes" / "bench").string() << "/$3.git\"\n"
+       << "    git init -q --bare \"$remote\" || exit 1\n"
+       << "    # Receive-side pack size limit, like a hosting service's push limit\n"
+       << "    [ -z \"$BENCH_RECEIVE_LIMIT\" ] || git --git-dir \"$remote\" config receive.maxInputSize \"$BENCH_RECEIVE_LIMIT\"\n"
+       << "    [ -z \"$BENCH_REMOTE_HOOKS\" ] || git --git-dir \"$remote\" config core.hooksPath \"$BENCH_REMOTE_HOOKS\"\n"
+       << "    echo \"https://github.com/bench/$3\" ;;\n"
+       << "  *) echo \"unsupported: gh $*\" >&2; exit 1 ;;\n"
+       << "esac\n";
+    gh.close();
+    fs::permissions(ghPath, fs::perms::owner_all | fs::perms::group_read | fs::perms::group_exec);
+    
+    std::ofstream gitConfig(sandbox / "gitconfig");
+    gitConfig << "[url \"file://" << (sandbox / "remotes").string() << "/\"]\n"
+              << "\tinsteadOf = https://github.com/\n"
+              << "[user]\n\tname = Benchmark\n\temail = benchmark@example.com\n"
+              << "[init]\n\tdefaultBranch = main\n"
+              << "[uploadpack]\n\tallowFilter = true\n";
+    gitConfig.close();
+    
+    std::string path = (sandbox / "bin").string() + ":" + getEnvironment("PATH");
+    setenv("PATH", path.c_str(), 1);
+    setenv("GIT_CONFIG_GLOBAL", (sandbox / "gitconfig").c_str(), 1);
+    setenv("GIT_CONFIG_NOSYSTEM", "1", 1);
+    setenv("HOME", (sandbox / "home").c_str(), 1);
+    setenv("XDG_CACHE_HOME", (sandbox / "home" / ".cache").c_str(), 1);
+    setenv("GH_CONFIG_DIR", (sandbox / "home" / "gh").c_str(), 1);
+    unsetenv("GH_TOKEN");
+    unsetenv("GITHUB_TOKEN");
+    unsetenv("GH_HOST");
+    
+    ProcessResult result;
+    return runProcess({"gh", "--version"}, result) && result.out.find("benchmark stub") != std::string::npos;
+}
+
+// Local stand-in for the GitHub REST API with GitHub's two kinds of limits: a
+// primary budget of `limit` calls per window of `windowSeconds`, announced in
+// x-ratelimit-* headers, and a secondary limit of `writesPerSecond` repository
+// creations per second, answered with 403 and Retry-After. The signed-in user
+// is "bench" and the only organization it belongs to is "acme". A repository
+// named "lost-*" is created without an answer: the connection is closed, as
+// when the network drops the response.
+class MockGitHubApi {
+public:
+    MockGitHubApi(int limit, int windowSeconds, int writesPerSecond)
+        : limit_(limit), windowSeconds_(std::max(1, windowSeconds)), writesPerSecond_(writesPerSecond) {}
+    
+    ~MockGitHubApi() {
+        stop_ = true;
+        if (acceptThread_.joinable()) {
+            acceptThread_.join();
+        }
+        for (auto& thread : connectionThreads_) {
+            thread.join();
+        }
+        if (listenFd_ >= 0) {
+            close(listenFd_);
+        }
+    }
+    
+    // Listen on an ephemeral loopback port
+    bool start() {
+        listenFd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (listenFd_ < 0 || bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(listenFd_, 64) != 0 || getsockname(listenFd_, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            return false;
+        }
+        port_ = ntohs(address.sin_port);
+        acceptThread_ = std::thread([this]() { acceptLoop(); });
+        return true;
+    }
+    
+    std::string url() const { return "http://127.0.0.1:" + std::to_string(port_); }
+    
+    size_t created() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return repositories_.size();
+    }
+    bool created(const std::string& fullName) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return repositories_.count(fullName) > 0;
+    }
+    size_t primaryRejections() const { return primaryRejections_; }
+    size_t secondaryRejections() const { return secondaryRejections_; }
+    
+private:
+    void acceptLoop() {
+        while (!stop_) {
+            pollfd entry = {listenFd_, POLLIN, 0};
+            if (poll(&entry, 1, 100) <= 0) {
+                continue;
+            }
+            int fd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd >= 0) {
+                connectionThreads_.emplace_back([this, fd]() { serve(fd); });
+            }
+        }
+    }
+    
+    // Answer keep-alive requests until the client closes or the server stops
+    void serve(int fd) {
+        std::string buffer;
+        while (!stop_) {
+            size_t headerEnd = buffer.find("\r\n\r\n");
+            size_t contentLength = 0;
+            if (headerEnd != std::string::npos) {
+                std::string lowerHeaders = buffer.substr(0, headerEnd);
+                std::transform(lowerHeaders.begin(), lowerHeaders.end(), lowerHeaders.begin(),
+                               [](unsigned char c) { return static_cast<char>(tolower(c)); });
+                size_t field = lowerHeaders.find("content-length:");
+                contentLength = field == std::string::npos ? 0 : std::strtoul(lowerHeaders.c_str() + field + 15, nullptr, 10);
+            }
+            if (headerEnd == std::string::npos || buffer.size() < headerEnd + 4 + contentLength) {
+                pollfd entry = {fd, POLLIN, 0};
+                if (poll(&entry, 1, 100) == 0) {
+                    continue;
+                }
+                char chunk[4096];
+                ssize_t bytesRead = recv(fd, chunk, sizeof(chunk), 0);
+                if (bytesRead <= 0) {
+                    break;
+                }
+                buffer.append(chunk, static_cast<size_t>(bytesRead));
+                continue;
+            }
+            std::istringstream requestLine(buffer.substr(0, buffer.find("\r\n")));
+            std::string method, path;
+            requestLine >> method >> path;
+            std::string body = buffer.substr(headerEnd + 4, contentLength);
+            buffer.erase(0, headerEnd + 4 + contentLength);
+            
+            std::string reply = handle(method, path, body);
+            if (reply.empty() ||
+                send(fd, reply.data(), reply.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(reply.size())) {
+                break;
+            }
+        }
+        close(fd);
+    }
+    
+    std::string handle(const std::string& method, const std::string& path, const std::string& body) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        long long now = currentUnixTime();
+        if (now >= windowStart_ + windowSeconds_) {
+            windowStart_ = now;
+            callsInWindow_ = 0;
+        }
+        ++callsInWindow_;
+        std::string rateHeaders = "X-RateLimit-Limit: " + std::to_string(limit_) +
+                                  "\r\nX-RateLimit-Remaining: " + std::to_string(std::max(0, limit_ - callsInWindow_)) +
+                                  "\r\nX-RateLimit-Reset: " + std::to_string(windowStart_ + windowSeconds_) + "\r\n";
+        if (callsInWindow_ > limit_) {
+            ++primaryRejections_;
+            return reply(403, rateHeaders, "{\"message\":\"API rate limit exceeded for user ID 1.\"}");
+        }
+        
+        if (method == "GET" && path == "/user") {
+            return reply(200, rateHeaders + "X-OAuth-Scopes: repo\r\n", "{\"login\":\"bench\",\"id\":1}");
+        }
+        if (method == "POST" && (path == "/user/repos" || path == "/orgs/acme/repos")) {
+            auto steadyNow = std::chrono::steady_clock::now();
+            while (!recentWrites_.empty() && steadyNow - recentWrites_.front() >= std::chrono::seconds(1)) {
+                recentWrites_.pop_front();
+            }
+            if (static_cast<int>(recentWrites_.size()) >= writesPerSecond_) {
+                ++secondaryRejections_;
+                return reply(403, rateHeaders + "Retry-After: 1\r\n",
+                             "{\"message\":\"You have exceeded a secondary rate limit. Please wait a few minutes "
+                             "before you try again.\"}");
+            }
+            recentWrites_.push_back(steadyNow);
+            JsonValue request;
+            std::string error;
+            std::string name = parseJson(body, request, error) && request.isObject() ? request.getString("name") : "";
+            std::string fullName = (path == "/user/repos" ? "bench/" : "acme/") + name;
+            if (name.compare(0, 5, "lost-") == 0) {
+                repositories_.insert(fullName);
+                return "";
+            }
+            if (name.empty() || !repositories_.insert(fullName).second) {
+                return reply(422, rateHeaders, "{\"message\":\"Repository creation failed.\"}");
+            }
+            return reply(201, rateHeaders, "{\"full_name\":" + jsonEscape(fullName) + "}");
+        }
+        if (method == "GET" && path.compare(0, 7, "/repos/") == 0 && repositories_.count(path.substr(7))) {
+            return reply(200, rateHeaders, "{\"full_name\":" + jsonEscape(path.substr(7)) + "}");
+        }
+        return reply(404, rateHeaders, "{\"message\":\"Not Found\"}");
+    }
+    
+    static std::string reply(int status, const std::string& headers, const std::string& body) {
+        return "HTTP/1.1 " + std::to_string(status) + " Mock\r\nContent-Type: application/json\r\n"
+               "Content-Length: " + std::to_string(body.size()) + "\r\n" + headers + "\r\n" + body;
+    }
+    
+    const int limit_;
+    const int windowSeconds_;
+    const int writesPerSecond_;
+    int listenFd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> stop_{false};
+    std::thread acceptThread_;
+    std::vector<std::thread> connectionThreads_;  // Only touched by the accept thread and the destructor
+    std::mutex mutex_;
+    long long windowStart_ = 0;
+    int callsInWindow_ = 0;
+    std::deque<std::chrono::steady_clock::time_point> recentWrites_;
+    std::set<std::string> repositories_;
+    std::atomic<size_t> primaryRejections_{0};
+    std::atomic<size_t> secondaryRejections_{0};
+};
+
+// Run an interactive flow with scripted answers and collect its traced steps
+ScenarioSample runScenario(const std::function<void()>& flow, const std::string& answers,
+                           const std::function<bool()>& verify) {
+    {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        traceEvents.clear();
+    }
+    
+    std::istringstream input(answers);
+    CapturedOutput output;
+    std::streambuf* originalInput = std::cin.rdbuf(input.rdbuf());
+    std::streambuf* originalOutput = std::cout.rdbuf(&output);
+    
+    auto startTime = std::chrono::steady_clock::now();
+    flow();
+    auto elapsed = std::chrono::steady_clock::now() - startTime;
+    
+    std::cin.rdbuf(originalInput);
+    std::cout.rdbuf(originalOutput);
+    
+    ScenarioSample sample;
+    sample.totalMs = std::chrono::duration<double, std::milli>(elapsed).count();
+    {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        for (const auto& event : traceEvents) {
+            if (std::strcmp(event.category, "step") == 0) {
+                sample.stepMs[event.name] += event.durationMicros / 1000.0;
+            } else if (std::strcmp(event.category, "process") == 0) {
+                sample.processes++;
+            }
+        }
+    }
+    sample.success = verify();
+    if (!sample.success) {
+        std::cerr << "Scenario output:\n" << output.text() << std::endl;
+    }
+    return sample;
+}
+
+double median(std::vector<double> values) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t middle = values.size() / 2;
+    return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2.0;
+}
+
+// JSON object of one scenario: median/min/max totals and median step times
+std::string scenarioJson(const std::string& name, const std::vector<ScenarioSample>& samples) {
+    std::vector<double> totals;
+    std::map<std::string, std::vector<double>> steps;
+    size_t failures = 0;
+    for (const auto& sample : samples) {
+        totals.push_back(sample.totalMs);
+        for (const auto& step : sample.stepMs) {
+            steps[step.first].push_back(step.second);
+        }
+        failures += sample.success ? 0 : 1;
+    }
+    
+    std::ostringstream json;
+    json << "{\"scenario\": " << jsonEscape(name) << ", \"runs\": " << samples.size()
+         << ", \"failures\": " << failures
+         << ", \"median_ms\": " << median(totals)
+         << ", \"min_ms\": " << *std::min_element(totals.begin(), totals.end())
+         << ", \"max_ms\": " << *std::max_element(totals.begin(), totals.end())
+         << ", \"processes\": " << samples.back().processes << ", \"steps_median_ms\": {";
+    bool first = true;
+    for (const auto& step : steps) {
+        json << (first ? "" : ", ") << jsonEscape(step.first) << ": " << median(step.second);
+        first = false;
+    }
+    json << "}}";
+    return json.str();
+}
+
+// JSON object of a correctness check; counted like a scenario for the exit code
+std::string checkJson(const std::string& name, size_t cases, size_t failures) {
+    return "{\"check\": " + jsonEscape(name) + ", \"failures\": " + std::to_string(failures) +
+           ", \"cases\": " + std::to_string(cases) + "}";
+}
+
+// Cases of a correctness check made of independent expectations: each one
+// that does not hold is reported on stderr under the check's label
+class CheckCases {
+public:
+    CheckCases(const std::string& name, const std::string& label) : name_(name), label_(label) {}
+    
+    bool expect(bool ok, const std::string& what) {
+        ++cases_;
+        if (!ok) {
+            std::cerr << label_ << ": " << what << std::endl;
+            ++failures_;
+        }
+        return ok;
+    }
+    
+    size_t failures() const { return failures_; }
+    std::string json() const { return checkJson(name_, cases_, failures_); }
+    
+private:
+    std::string name_;
+    std::string label_;
+    size_t cases_ = 0;
+    size_t failures_ = 0;
+};
+
+// Output of a git command run in a directory
+std::string gitOutput(const fs::path& directory, const std::vector<std::string>& args,
+                      const std::string* input = nullptr) {
+    std::vector<std::string> command = {"git"};
+    command.insert(command.end(), args.begin(), args.end());
+    ProcessOptions options;
+    options.workingDir = directory.string();
+    options.input = input;
+    ProcessResult result;
+    runProcess(command, result, options);
+    return result.out;
+}
+
+// Split NUL-terminated records
+std::vector<std::string> splitRecords(const std::string& text) {
+    std::vector<std::string> records;
+    size_t start = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\0') {
+            records.emplace_back(text, start, i - start);
+            start = i + 1;
+        }
+    }
+    return records;
+}
+
+// Report the differences between two sorted path lists; returns their number
+size_t comparePathLists(const std::string& what, const std::vector<std::string>& expected,
+                        const std::vector<std::string>& actual) {
+    std::vector<std::string> missing, extra;
+    std::set_difference(expected.begin(), expected.end(), actual.begin(), actual.end(), std::back_inserter(missing));
+    std::set_difference(actual.begin(), actual.end(), expected.begin(), expected.end(), std::back_inserter(extra));
+    for (const auto& path : missing) {
+        std::cerr << what << ": missing " << path << std::endl;
+    }
+    for (const auto& path : extra) {
+        std::cerr << what << ": unexpected " << path << std::endl;
+    }
+    return missing.size() + extra.size();
+}
+
+// Tree with nested .gitignore files drawn from git's pattern forms (negation,
+// directory-only, anchored, wildcards, "**"). Some files inside ignored
+// directories are force-added, as git only prunes directories without tracked files.
+void generateIgnoreTree(const fs::path& root, std::mt19937& random) {
+    static const char* directoryNames[] = {"build", "src", "out", "lib", "node_modules", "tmp", "docs", "x", "y"};
+    static const char* fileNames[] = {"a.txt", "b.log", "keep.log", "c1", "c2", "d1.tmp", "Makefile", "main.o", "y"};
+    static const char* patterns[] = {"*.log", "!keep.log", "build/", "/out", "x/**/y", "**/tmp", "c*", "!c2",
+                                     "d?.tmp", "src/*.o", "[ab].txt", "lib", "!lib/", "y/", "*.o", "!main.o",
+                                     "node_modules/", "docs/**", "/a.txt", "\\!c1", "*.tmp ", "# comment"};
+    std::vector<fs::path> directories = {root};
+    for (int i = 0; i < 30; ++i) {
+        const fs::path& parent = directories[random() % directories.size()];
+        if (std::distance(parent.begin(), parent.end()) - std::distance(root.begin(), root.end()) < 4) {
+            directories.push_back(parent / directoryNames[random() % 9]);
+        }
+    }
+    for (const auto& directory : directories) {
+        fs::create_directories(directory);
+    }
+    for (const auto& directory : directories) {
+        for (const char* name : fileNames) {
+            if (random() % 3 == 0 && !fs::is_directory(directory / name)) {
+                std::ofstream(directory / name) << name << "\n";
+            }
+        }
+        if (random() % 5 < 2) {
+            std::ofstream gitignore(directory / ".gitignore");
+            for (unsigned line = random() % 4 + 1; line > 0; --line) {
+                gitignore << patterns[random() % (sizeof(patterns) / sizeof(patterns[0]))] << "\n";
+            }
+        }
+    }
+    
+    gitOutput(root, {"init", "-q"});
+    std::ofstream(root / ".git" / "info" / "exclude") << patterns[random() % 6] << "\n";
+    std::vector<std::string> files;
+    for (const auto& entry : fs::recursive_directory_iterator(root)) {
+        std::string relative = fs::relative(entry.path(), root).generic_string();
+        if (entry.is_regular_file() && relative.compare(0, 5, ".git/") != 0) {
+            files.push_back(relative);
+        }
+    }
+    std::sort(files.begin(), files.end());
+    std::vector<std::string> forced = {"add", "-f", "--"};
+    for (const auto& file : files) {
+        if (random() % 8 == 0) {
+            forced.push_back(file);
+        }
+    }
+    if (forced.size() > 3) {
+        gitOutput(root, forced);
+    }
+}
+
+// The in-process ignore engine against git on generated trees: the ignored
+// state of every file against "git check-ignore", and the untracked files of
+// the change detector against "git ls-files --others --exclude-standard"
+std::string runIgnoreCheck(const fs::path& sandbox, unsigned seed) {
+    const int trees = 20;
+    size_t cases = 0;
+    size_t failures = 0;
+    for (int tree = 0; tree < trees; ++tree) {
+        fs::path root = sandbox / "checks" / ("ignore" + std::to_string(tree));
+        std::mt19937 random(seed + static_cast<unsigned>(tree));
+        generateIgnoreTree(root, random);
+        
+        std::string input;
+        std::vector<std::string> files;
+        for (const auto& entry : fs::recursive_directory_iterator(root)) {
+            std::string relative = fs::relative(entry.path(), root).generic_string();
+            if (entry.is_regular_file() && relative.compare(0, 5, ".git/") != 0) {
+                files.push_back(relative);
+                input.append(relative.c_str(), relative.size() + 1);
+            }
+        }
+        std::vector<std::string> expectedIgnored =
+            splitRecords(gitOutput(root, {"check-ignore", "--no-index", "--stdin", "-z"}, &input));
+        std::sort(expectedIgnored.begin(), expectedIgnored.end());
+        IgnoreMatcher matcher(root.string());
+        std::vector<std::string> ignored;
+        for (const auto& file : files) {
+            if (matcher.isPathIgnored(file, false)) {
+                ignored.push_back(file);
+            }
+        }
+        std::sort(ignored.begin(), ignored.end());
+        failures += comparePathLists(root.string() + " ignored", expectedIgnored, ignored);
+        
+        std::vector<std::string> expectedUntracked =
+            splitRecords(gitOutput(root, {"ls-files", "-z", "--others", "--exclude-standard"}));
+        std::sort(expectedUntracked.begin(), expectedUntracked.end());
+        WorkingTreeChanges changes;
+        if (!detectWorkingTreeChanges(root.string(), changes)) {
+            std::cerr << root.string() << ": change detection fell back to git" << std::endl;
+            ++failures;
+        }
+        failures += comparePathLists(root.string() + " untracked", expectedUntracked, changes.newFiles);
+        cases += files.size();
+    }
+    std::cout << "Ignore check: " << cases << " files in " << trees << " trees, " << failures << " mismatch(es)"
+              << std::endl;
+    return checkJson("ignore_vs_git", cases, failures);
+}
+
+// Changes git reports for the working tree, from "git status --porcelain":
+// untracked and intent-to-add files are new
+WorkingTreeChanges gitStatusChanges(const fs::path& root) {
+    WorkingTreeChanges changes;
+    for (const auto& record : splitRecords(gitOutput(root, {"status", "--porcelain", "-z", "--untracked-files=all"}))) {
+        if (record.size() < 4) {
+            continue;
+        }
+        std::string path = record.substr(3);
+        if (record[1] == '?' || record[1] == 'A') {
+            changes.newFiles.push_back(path);
+        } else if (record[1] == 'M' || record[1] == 'T') {
+            changes.modifiedFiles.push_back(path);
+        } else if (record[1] == 'D') {
+            changes.deletedFiles.push_back(path);
+        }
+    }
+    for (auto* list : {&changes.newFiles, &changes.modifiedFiles, &changes.deletedFiles}) {
+        std::sort(list->begin(), list->end());
+    }
+    return changes;
+}
+
+size_t compareChanges(const std::string& what, const WorkingTreeChanges& expected, WorkingTreeChanges actual) {
+    for (auto* list : {&actual.newFiles, &actual.modifiedFiles, &actual.deletedFiles}) {
+        std::sort(list->begin(), list->end());
+    }
+    return comparePathLists(what + " new", expected.newFiles, actual.newFiles) +
+           comparePathLists(what + " modified", expected.modifiedFiles, actual.modifiedFiles) +
+           comparePathLists(what + " deleted", expected.deletedFiles, actual.deletedFiles);
+}
+
+// The index reader and change detector against index files written by the
+// local git: versions 2, 3 (extended flags from intent-to-add and
+// skip-worktree entries) and 4 (prefix-compressed paths) are compared entry by
+// entry with "git ls-files --stage" and the detected changes with
+// "git status --porcelain". A split index has to fall back to git commands
+// and give the same changes.
+std::string runIndexCheck(const fs::path& sandbox, unsigned seed) {
+    fs::path root = sandbox / "checks" / "index";
+    generateSyntheticTree(root, 400, seed);
+    gitOutput(root, {"init", "-q"});
+    gitOutput(root, {"add", "."});
+    gitOutput(root, {"commit", "-q", "-m", "Index check"});
+    
+    // An assume-unchanged entry and a mode change; entries with extended flags
+    // (which need version 3 or later) are added after the version 2 round
+    std::vector<std::string> tracked = splitRecords(gitOutput(root, {"ls-files", "-z"}));
+    gitOutput(root, {"update-index", "--assume-unchanged", tracked[2]});
+    fs::permissions(root / tracked[3], fs::perms::owner_exec, fs::perm_options::add);
+    mutateSyntheticTree(root, seed + 1);
+    
+    size_t cases = 0;
+    size_t failures = 0;
+    for (const char* version : {"2", "3", "4"}) {
+        std::string what = root.string() + " index v" + version;
+        if (version[0] == '3') {
+            std::ofstream(root / "intent.txt") << "intent to add\n";
+            gitOutput(root, {"add", "-N", "intent.txt"});
+            gitOutput(root, {"update-index", "--skip-worktree", tracked[1]});
+            std::ofstream(root / tracked[1], std::ios::app) << "hidden by skip-worktree\n";
+        }
+        gitOutput(root, {"update-index", "--index-version", version});
+        
+        std::vector<IndexEntry> entries;
+        std::string error;
+        if (!readGitIndex(root / ".git" / "index", entries, error)) {
+            std::cerr << what << ": " << error << std::endl;
+            ++failures;
+            continue;
+        }
+        std::ifstream indexFile(root / ".git" / "index", std::ios::binary);
+        char header[8] = {};
+        indexFile.read(header, sizeof(header));
+        if (header[7] != version[0] - '0') {
+            std::cerr << what << ": git wrote version " << int(header[7]) << std::endl;
+            ++failures;
+        }
+        
+        // "mode sha stage<TAB>path"; intent-to-add entries are not part of the reader's result
+        std::vector<std::string> expectedEntries;
+        for (const auto& record : splitRecords(gitOutput(root, {"ls-files", "--stage", "-z"}))) {
+            if (record.size() < 11 || record.compare(record.size() - 11, 11, "\tintent.txt") != 0) {
+                expectedEntries.push_back(record);
+            }
+        }
+        std::vector<std::string> parsedEntries;
+        for (const auto& entry : entries) {
+            char mode[8];
+            std::snprintf(mode, sizeof(mode), "%06o", entry.mode);
+            parsedEntries.push_back(std::string(mode) + " " + toHex(entry.sha, 20) + " 0\t" + entry.path);
+        }
+        std::sort(expectedEntries.begin(), expectedEntries.end());
+        std::sort(parsedEntries.begin(), parsedEntries.end());
+        failures += comparePathLists(what + " entries", expectedEntries, parsedEntries);
+        
+        WorkingTreeChanges changes;
+        if (!detectWorkingTreeChanges(root.string(), changes)) {
+            std::cerr << what << ": change detection fell back to git" << std::endl;
+            ++failures;
+        }
+        failures += compareChanges(what, gitStatusChanges(root), changes);
+        cases += entries.size();
+    }
+    
+    gitOutput(root, {"update-index", "--split-index"});
+    std::vector<IndexEntry> entries;
+    std::string error;
+    WorkingTreeChanges changes;
+    if (readGitIndex(root / ".git" / "index", entries, error) || detectWorkingTreeChanges(root.string(), changes)) {
+        std::cerr << root.string() << ": split index was read natively" << std::endl;
+        ++failures;
+    }
+    repositoryDirectory = root.string();
+    failures += compareChanges(root.string() + " split index", gitStatusChanges(root), collectChangedFiles());
+    repositoryDirectory.clear();
+    
+    std::cout << "Index check: " << cases << " entries in v2-v4 and split indexes, " << failures << " mismatch(es)"
+              << std::endl;
+    return checkJson("index_vs_git", cases, failures);
+}
+
+// The repository session's long-lived git helpers against changes made after
+// they started, as in watch mode: a file added to the index, a rule added to
+// the top-level and to a nested .gitignore, and a rule removed again
+std::string runSessionRefreshCheck(const fs::path& sandbox) {
+    fs::path root = sandbox / "work" / "session-check";
+    fs::create_directories(root / "sub");
+    gitOutput(sandbox, {"init", "-q", root.string()});
+    std::ofstream(root / "a") << "a\n";
+    std::ofstream(root / "b") << "b\n";
+    std::ofstream(root / "x.log") << "x\n";
+    std::ofstream(root / "sub" / "y.tmp") << "y\n";
+    gitOutput(root, {"add", "a"});
+    repositoryDirectory = root.string();
+    std::shared_ptr<GitSession> session = gitSession();
+    
+    CheckCases check("session_refresh", "Session check");
+    auto staged = [&](const std::string& path) {
+        std::vector<std::string> objectNames;
+        return session->resolveObjects({":" + path}, objectNames) && !objectNames[0].empty();
+    };
+    auto ignored = [&](const std::string& path) {
+        std::vector<bool> result;
+        return session->ignoredPaths({path}, result) && result[0];
+    };
+    check.expect(staged("a") && !staged("b"), "the index lookup is wrong before any change");
+    check.expect(!ignored("x.log") && !ignored("sub/y.tmp"), "files are ignored before any rule");
+    
+    gitOutput(root, {"add", "b"});
+    check.expect(staged("b"), "a file added to the index after the helper started is reported missing");
+    std::ofstream(root / ".gitignore") << "*.log\n";
+    check.expect(ignored("x.log"), "a rule added to .gitignore is not seen");
+    std::ofstream(root / "sub" / ".gitignore") << "*.tmp\n";
+    check.expect(ignored("sub/y.tmp"), "a rule added to a nested .gitignore is not seen");
+    std::ofstream(root / ".gitignore", std::ios::trunc) << "# none\n";
+    check.expect(!ignored("x.log"), "a rule removed from .gitignore still applies");
+    
+    session.reset();
+    closeGitSession(root.string());
+    repositoryDirectory.clear();
+    std::error_code ec;
+    fs::remove_all(root, ec);
+    std::cout << "Session check: " << check.failures() << " mismatch(es)" << std::endl;
+    return check.json();
+}
+
+// The initial commit built without git (blobs deflated straight into a pack)
+// against git's own result: a tree with two files over the 32 MB streaming
+// threshold, one compressible and one not, has to leave three packs (one per
+// large file) and no temporary files, has to be pushed with the tree
+// `git add -A && git write-tree` gives for the same files, and both the
+// project's repository and the remote have to pass `git fsck --strict`
+std::string runCreateCheck(const fs::path& sandbox, unsigned seed) {
+    fs::path project = sandbox / "work" / "create-check";
+    fs::path remote = sandbox / "remotes" / "bench" / "create-check.git";
+    fs::path expected = sandbox / "create-check-expected.git";
+    std::mt19937 random(seed);
+    generateSyntheticTree(project, 400, seed);
+    fs::create_directories(project / "large");
+    writeSyntheticFile(project / "large" / "capture.bin", 40 * 1024 * 1024, true, random);
+    writeSyntheticFile(project / "large" / "server.log", 40 * 1024 * 1024, false, random);
+    
+    size_t failures = 0;
+    ScenarioSample sample = runScenario(createProject, "create-check\nbenchmark\ny\n" + project.string() +
+                                        "\nn\nInitial upload\n", []() { return true; });
+    size_t packs = 0;
+    size_t temporaryFiles = 0;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(project / ".git" / "objects" / "pack", ec)) {
+        packs += entry.path().extension() == ".pack";
+        temporaryFiles += entry.path().filename().string().compare(0, 9, "tmp_pack_") == 0;
+    }
+    if (packs != 3 || temporaryFiles != 0) {
+        std::cerr << "Create check: the initial commit left " << packs << " pack(s) and " << temporaryFiles
+                  << " temporary file(s), expected 3 and 0" << std::endl;
+        ++failures;
+    }
+    
+    gitOutput(sandbox, {"init", "-q", "--bare", expected.string()});
+    gitOutput(project, {"--git-dir", expected.string(), "--work-tree", project.string(), "add", "-A", "."});
+    std::string expectedTree = trimOutput(gitOutput(project, {"--git-dir", expected.string(), "write-tree"}));
+    std::string pushedTree = trimOutput(gitOutput(sandbox, {"--git-dir", remote.string(), "rev-parse", "main^{tree}"}));
+    if (expectedTree.empty() || pushedTree != expectedTree) {
+        std::cerr << "Create check: pushed tree " << pushedTree << ", git writes " << expectedTree << std::endl;
+        ++failures;
+    }
+    for (const fs::path& gitDir : {project / ".git", remote}) {
+        ProcessResult result;
+        if (!runProcess({"git", "--git-dir", gitDir.string(), "fsck", "--strict", "--no-dangling"}, result)) {
+            std::cerr << "Create check: git fsck --strict failed in " << gitDir.string() << ":\n"
+                      << result.out << result.err << std::endl;
+            ++failures;
+        }
+    }
+    
+    fs::remove_all(project, ec);
+    fs::remove_all(remote, ec);
+    fs::remove_all(expected, ec);
+    std::cout << "Create check: 2 files over 32 MB, " << sample.totalMs << " ms, " << failures << " mismatch(es)"
+              << std::endl;
+    return checkJson("create_vs_git", 4, failures);
+}
+
+// Remote update against a bare repository given as a plain absolute path:
+// the kept working copy has to be a private, shallow, blob-less clone
+// (remote.origin.promisor set, blobs outside the sparse paths missing)
+std::string runPartialCloneCheck(const fs::path& sandbox, unsigned seed) {
+    fs::path source = sandbox / "work" / "partial-source";
+    fs::path remote = sandbox / "remotes" / "partial-check.git";
+    fs::path patch = sandbox / "work" / "partial-patch";
+    generateSyntheticTree(source, 200, seed);
+    gitOutput(source, {"init", "-q"});
+    gitOutput(source, {"add", "-A"});
+    gitOutput(source, {"commit", "-q", "-m", "Initial"});
+    gitOutput(sandbox, {"clone", "-q", "--bare", source.string(), remote.string()});
+    std::mt19937 random(seed);
+    fs::create_directories(patch / "patch");
+    writeSyntheticFile(patch / "patch" / "applied.txt", 2048, false, random);
+    
+    RemoteUpdateOptions remoteUpdate;
+    remoteUpdate.repository = remote.string();
+    remoteUpdate.sourcePath = patch.string();
+    remoteUpdate.commitMessage = "Partial clone check";
+    remoteUpdate.keepWorkingCopy = true;
+    repositoryDirectory.clear();
+    CapturedOutput output;
+    std::streambuf* originalOutput = std::cout.rdbuf(&output);
+    int exitCode = runRemoteUpdate(remoteUpdate);
+    std::cout.rdbuf(originalOutput);
+    std::string text = output.text();
+    const std::string keptPrefix = "Working copy kept at ";
+    size_t kept = text.find(keptPrefix);
+    fs::path workingCopy = kept == std::string::npos ? fs::path()
+        : fs::path(text.substr(kept + keptPrefix.size(), text.find('\n', kept) - kept - keptPrefix.size()));
+    
+    CheckCases check("remote_update_partial_clone", "Partial clone check");
+    std::string pushed = trimOutput(gitOutput(sandbox, {"--git-dir", remote.string(), "log", "-1", "--format=%s"}));
+    check.expect(exitCode == 0 && pushed == "Partial clone check", "the update was not pushed:\n" + text);
+    check.expect(!workingCopy.empty() &&
+                 (fs::status(workingCopy).permissions() & fs::perms::all) == fs::perms::owner_all,
+                 "the working copy is not a private directory");
+    check.expect(trimOutput(gitOutput(workingCopy, {"config", "remote.origin.promisor"})) == "true",
+                 "remote.origin.promisor is not set");
+    check.expect(fs::exists(workingCopy / ".git" / "shallow"), "the clone is not shallow");
+    std::string objects = gitOutput(workingCopy, {"rev-list", "--objects", "--missing=print", "HEAD~1"});
+    std::istringstream objectLines(objects);
+    std::string line;
+    size_t missing = 0;
+    while (std::getline(objectLines, line)) {
+        missing += !line.empty() && line[0] == '?';
+    }
+    check.expect(missing > 0, "all blobs of the repository were downloaded");
+    
+    std::error_code ec;
+    if (!workingCopy.empty()) {
+        fs::remove_all(workingCopy, ec);
+    }
+    fs::remove_all(source, ec);
+    fs::remove_all(remote, ec);
+    fs::remove_all(patch, ec);
+    std::cout << "Partial clone check: " << missing << " blob(s) left on the server, " << check.failures()
+              << " mismatch(es)" << std::endl;
+    return check.json();
+}
+
+// Chunked create into a remote with receive.maxInputSize whose pushes are
+// refused after the first part (a pre-receive hook), then the commit of the
+// next part made without recording it, as when the process is stopped right
+// after committing; --resume-upload has to take that commit over and finish
+std::string runResumeCheck(const fs::path& sandbox, unsigned seed) {
+    fs::path project = sandbox / "work" / "resume-check";
+    fs::path remote = sandbox / "remotes" / "bench" / "resume-check.git";
+    fs::path hooks = sandbox / "resume-hooks";
+    fs::path pushCounter = sandbox / "resume-pushes";
+    SyntheticTreeStats stats = generateSyntheticTree(project, 300, seed);
+    fs::create_directories(hooks);
+    {
+        std::ofstream hook(hooks / "pre-receive");
+        hook << "#!/bin/sh\n"
+             << "n=$(cat \"" << pushCounter.string() << "\" 2>/dev/null || echo 0)\n"
+             << "echo $((n + 1)) > \"" << pushCounter.string() << "\"\n"
+             << "[ \"$n\" -lt 1 ] || { echo \"connection reset\" >&2; exit 1; }\n";
+    }
+    fs::permissions(hooks / "pre-receive", fs::perms::owner_all);
+    setenv("BENCH_REMOTE_HOOKS", hooks.c_str(), 1);
+    setenv("BENCH_RECEIVE_LIMIT", std::to_string(stats.bytes / 2).c_str(), 1);
+    uploadChunkBytes = static_cast<long long>(stats.bytes / 4);
+    
+    CheckCases check("chunked_resume", "Resume check");
+    runScenario(createProject, "resume-check\nbenchmark\ny\n" + project.string() + "\nn\nResumed upload\n",
+                []() { return true; });
+    repositoryDirectory = project.string();
+    ChunkedUpload upload;
+    bool interrupted = loadChunkedUpload(upload);
+    check.expect(interrupted && upload.pushed == 1 && upload.commits.size() < upload.chunks.size(),
+                 "the upload was not interrupted after the first part");
+    check.expect(trimOutput(gitOutput(sandbox, {"--git-dir", remote.string(), "rev-list", "--count", "main"})) == "1",
+                 "the remote does not hold just the first part");
+    
+    if (interrupted && upload.commits.size() < upload.chunks.size()) {
+        size_t chunk = upload.commits.size();
+        std::vector<std::string> add = {"add", "--"};
+        add.insert(add.end(), upload.chunks[chunk].begin(), upload.chunks[chunk].end());
+        gitOutput(project, add);
+        gitOutput(project, {"commit", "-q", "-m", chunkCommitMessage(upload, chunk)});
+        closeGitSession(project.string());
+        
+        fs::remove(pushCounter);
+        std::ofstream(pushCounter) << "-100\n";
+        CapturedOutput output;
+        std::streambuf* originalOutput = std::cout.rdbuf(&output);
+        int exitCode = resumeChunkedUpload(project.string());
+        std::cout.rdbuf(originalOutput);
+        std::string localHead = trimOutput(gitOutput(project, {"rev-parse", "HEAD"}));
+        std::string remoteHead = trimOutput(gitOutput(sandbox, {"--git-dir", remote.string(), "rev-parse", "main"}));
+        std::string files = gitOutput(sandbox, {"--git-dir", remote.string(), "ls-tree", "-r", "--name-only", "main"});
+        check.expect(exitCode == 0 && output.text().find("committed before the interruption") != std::string::npos,
+                     "the resume did not take over the unrecorded part:\n" + output.text());
+        std::string commits = trimOutput(gitOutput(project, {"rev-list", "--count", "HEAD"}));
+        check.expect(!localHead.empty() && localHead == remoteHead && commits == std::to_string(upload.chunks.size()),
+                     "the remote does not end at the last part");
+        check.expect(static_cast<size_t>(std::count(files.begin(), files.end(), '\n')) == stats.files,
+                     "the remote does not hold every file");
+        check.expect(!fs::exists(chunkedUploadStatePath()), "the upload state was left behind");
+    }
+    
+    uploadChunkBytes = -1;
+    unsetenv("BENCH_RECEIVE_LIMIT");
+    unsetenv("BENCH_REMOTE_HOOKS");
+    closeGitSession(project.string());
+    repositoryDirectory.clear();
+    std::error_code ec;
+    fs::remove_all(project, ec);
+    fs::remove_all(remote, ec);
+    fs::remove_all(hooks, ec);
+    fs::remove(pushCounter, ec);
+    std::cout << "Resume check: " << check.failures() << " mismatch(es)" << std::endl;
+    return check.json();
+}
+
+// Pre-stage scan rules: an "allow *" in the project's own rules file is
+// ignored unless GITHUB_AUTOMATION_SCAN_REPO_ALLOW=1, and with more literal
+// pairs than the SSE2 pass takes (extra rules from GITHUB_AUTOMATION_SCAN_RULES)
+// both built-in and extra secrets are still found
+std::string runScanRulesCheck(const fs::path& sandbox, unsigned seed) {
+    fs::path project = sandbox / "work" / "scan-check";
+    fs::path ruleFile = sandbox / "scan-rules";
+    std::mt19937 random(seed);
+    fs::create_directories(project);
+    auto token = [&](size_t length) {
+        static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+        std::string text;
+        for (size_t i = 0; i < length; ++i) {
+            text += alphabet[random() % 36];
+        }
+        return text;
+    };
+    std::ofstream(project / ".env") << "API_KEY=benchmark\n";
+    std::ofstream(project / "deploy.txt") << "aws_access_key_id = AKIA" << token(16) << "\n";
+    std::ofstream(project / "notes.txt") << "internal: zq" << token(24) << "\n";
+    std::ofstream(project / "readme.txt") << "nothing to see here\n";
+    std::ofstream(project / ".github_automation_scan") << "allow *\n";
+    {
+        std::ofstream rules(ruleFile);
+        for (char first = 'a'; first <= 'z'; ++first) {
+            rules << "secret extra_" << first << " " << first << "q [A-Z0-9]{24}\n";
+        }
+    }
+    setenv("GITHUB_AUTOMATION_SCAN_RULES", ruleFile.c_str(), 1);
+    repositoryDirectory = project.string();
+    
+    size_t failures = 0;
+    const std::vector<std::string> allFiles = {".env", ".github_automation_scan", "deploy.txt", "notes.txt", "readme.txt"};
+    for (bool applyRepositoryAllow : {false, true}) {
+        if (applyRepositoryAllow) {
+            setenv("GITHUB_AUTOMATION_SCAN_REPO_ALLOW", "1", 1);
+        }
+        std::vector<std::string> files = allFiles;
+        CapturedOutput output;
+        std::streambuf* originalOutput = std::cout.rdbuf(&output);
+        bool screened = screenFilesBeforeStaging(files);
+        std::cout.rdbuf(originalOutput);
+        std::vector<std::string> expected = applyRepositoryAllow ? allFiles
+            : std::vector<std::string>{".github_automation_scan", "readme.txt"};
+        bool listed = output.text().find(applyRepositoryAllow ? "Applying allow rules" : "Ignoring allow rules") !=
+                      std::string::npos;
+        if (!screened || files != expected || !listed) {
+            std::cerr << "Scan rules check (repository allow rules " << (applyRepositoryAllow ? "on" : "off")
+                      << "): " << files.size() << " file(s) left to stage:\n" << output.text() << std::endl;
+            ++failures;
+        }
+    }
+    
+    unsetenv("GITHUB_AUTOMATION_SCAN_REPO_ALLOW");
+    
+    // Deleting a tracked file that matches a rule has to be committed; a new
+    // secret next to it is still held back
+    gitOutput(project, {"init", "-q", "-b", "main"});
+    gitOutput(project, {"add", "-A"});
+    gitOutput(project, {"commit", "-q", "-m", "Scan check"});
+    fs::remove(project / ".env");
+    std::ofstream(project / "token.txt") << "internal: zq" << token(24) << "\n";
+    std::ofstream(project / "readme.txt") << "still nothing to see here\n";
+    {
+        CapturedOutput output;
+        std::streambuf* originalOutput = std::cout.rdbuf(&output);
+        bool committed = addFilesAndCommit("Delete .env");
+        closeGitSession(project.string());
+        std::cout.rdbuf(originalOutput);
+        std::string tree = gitOutput(project, {"ls-tree", "-r", "--name-only", "HEAD"});
+        if (!committed || tree.find(".env\n") != std::string::npos || tree.find("token.txt") != std::string::npos ||
+            gitOutput(project, {"status", "--porcelain"}) != "?? token.txt\n") {
+            std::cerr << "Scan rules check (tracked .env deleted): committed tree:\n" << tree << output.text() << std::endl;
+            ++failures;
+        }
+    }
+    
+    unsetenv("GITHUB_AUTOMATION_SCAN_RULES");
+    repositoryDirectory.clear();
+    std::error_code ec;
+    fs::remove_all(project, ec);
+    fs::remove(ruleFile, ec);
+    std::cout << "Scan rules check: " << failures << " mismatch(es)" << std::endl;
+    return checkJson("scan_rules", 3, failures);
+}
+
+// Large-file routing end to end against a file-based LFS store (lfs.url
+// pointing at a local bare repository): a create with a binary over the
+// threshold has to push an LFS pointer and put the content into the store,
+// and a create whose repository creation fails has to leave the project's
+// .gitattributes as it was. Skipped when git-lfs is not installed.
+std::string runLfsCheck(const fs::path& sandbox, unsigned seed) {
+    ProcessResult result;
+    if (!runProcess({"git", "lfs", "version"}, result)) {
+        std::cout << "LFS check skipped: git-lfs is not installed" << std::endl;
+        return "{\"check\": \"lfs_file_store\", \"failures\": 0, \"cases\": 0, \"skipped\": true}";
+    }
+    fs::path store = sandbox / "lfs-store.git";
+    gitOutput(sandbox, {"init", "-q", "--bare", store.string()});
+    setenv("GITHUB_AUTOMATION_LFS_URL", ("file://" + store.string()).c_str(), 1);
+    largeFileThresholdMb = 1;
+    const std::string attributes = "*.txt text\n";
+    auto generateProject = [&](const fs::path& root) {
+        std::mt19937 random(seed);
+        generateSyntheticTree(root, 50, seed);
+        fs::create_directories(root / "assets");
+        writeSyntheticFile(root / "assets" / "video.bin", 3 * 1024 * 1024, true, random);
+        std::ofstream(root / ".gitattributes") << attributes;
+    };
+    
+    size_t failures = 0;
+    fs::path project = sandbox / "work" / "lfs-check";
+    fs::path remote = sandbox / "remotes" / "bench" / "lfs-check.git";
+    generateProject(project);
+    ScenarioSample sample = runScenario(createProject, "lfs-check\nbenchmark\ny\n" + project.string() +
+                                        "\nn\nLFS upload\n", [&]() {
+        ProcessResult show;
+        runProcess({"git", "--git-dir", remote.string(), "show", "main:assets/video.bin"}, show);
+        size_t oid = show.out.find("oid sha256:");
+        if (show.out.compare(0, 40, "version https://git-lfs.github.com/spec/") != 0 || oid == std::string::npos) {
+            std::cerr << "LFS check: assets/video.bin was not pushed as a pointer" << std::endl;
+            return false;
+        }
+        std::string hash = show.out.substr(oid + 11, 64);
+        bool stored = false;
+        for (const auto& entry : fs::recursive_directory_iterator(store)) {
+            stored = stored || entry.path().filename() == hash;
+        }
+        runProcess({"git", "--git-dir", remote.string(), "show", "main:.gitattributes"}, show);
+        bool routed = show.out.compare(0, attributes.size(), attributes) == 0 &&
+                      show.out.find("/assets/video.bin filter=lfs") != std::string::npos;
+        if (!stored || !routed) {
+            std::cerr << "LFS check: object " << (stored ? "" : "not ") << "in the store, .gitattributes "
+                      << (routed ? "" : "not ") << "extended" << std::endl;
+        }
+        return stored && routed;
+    });
+    failures += sample.success ? 0 : 1;
+    
+    fs::path failedProject = sandbox / "work" / "fail-lfs-check";
+    generateProject(failedProject);
+    runScenario(createProject, "fail-lfs-check\nbenchmark\ny\n" + failedProject.string() + "\nn\nLFS upload\n",
+                []() { return true; });
+    std::ifstream attributesFile(failedProject / ".gitattributes");
+    std::string restored((std::istreambuf_iterator<char>(attributesFile)), std::istreambuf_iterator<char>());
+    if (restored != attributes || fs::exists(failedProject / ".git")) {
+        std::cerr << "LFS check: failed create left .gitattributes as:\n" << restored << std::endl;
+        ++failures;
+    }
+    
+    largeFileThresholdMb = -1;
+    unsetenv("GITHUB_AUTOMATION_LFS_URL");
+    std::error_code ec;
+    fs::remove_all(project, ec);
+    fs::remove_all(failedProject, ec);
+    std::cout << "LFS check: " << failures << " mismatch(es)" << std::endl;
+    return checkJson("lfs_file_store", 2, failures);
+}
+
+// "owner/name" repository names against the mock API: the user's own login
+// (in any case) goes to /user/repos, an organization to /orgs/{owner}/repos,
+// and an owner the API does not know falls back to gh. A creation whose
+// response is lost is looked up instead of being sent again through gh.
+std::string runOwnerCheck(MockGitHubApi& mockApi, const fs::path& sandbox) {
+    CheckCases check("repo_owner_routing", "Owner check");
+    repositoryDirectory.clear();  // The last scenario's project is gone; gh runs from here
+    CapturedOutput output;
+    std::streambuf* originalOutput = std::cout.rdbuf(&output);
+    bool own = createRemoteRepository("bench/owner-check", "", true);
+    bool ownCase = createRemoteRepository("Bench/owner-check-case", "", true);
+    bool organization = createRemoteRepository("acme/owner-check", "", true);
+    bool other = createRemoteRepository("someone/owner-check", "", true);
+    bool lost = createRemoteRepository("lost-owner-check", "", true);
+    std::cout.rdbuf(originalOutput);
+    
+    check.expect(own && mockApi.created("bench/owner-check"), "bench/owner-check was not created through /user/repos");
+    check.expect(ownCase && mockApi.created("bench/owner-check-case"),
+                 "Bench/owner-check-case was not created through /user/repos");
+    check.expect(organization && mockApi.created("acme/owner-check"),
+                 "acme/owner-check was not created through /orgs/acme/repos");
+    check.expect(other && fs::exists(sandbox / "remotes" / "bench" / "someone" / "owner-check.git"),
+                 "someone/owner-check did not fall back to gh after the 404");
+    check.expect(lost && mockApi.created("bench/lost-owner-check") &&
+                 !fs::exists(sandbox / "remotes" / "bench" / "lost-owner-check.git"),
+                 "lost-owner-check was not found on GitHub after its response was lost:\n" + output.text());
+    std::cout << "Owner check: " << check.failures() << " mismatch(es)" << std::endl;
+    return check.json();
+}
+
+// Listing a project whose node_modules/ holds most of its files, which
+// .gitignore excludes, against "git ls-files --others --exclude-standard"
+std::string runIgnoredTreeScenario(const fs::path& sandbox, size_t ignoredFiles, int runs, unsigned seed) {
+    fs::path root = sandbox / "work" / "node_modules_project";
+    std::mt19937 random(seed);
+    for (size_t i = 0; i < ignoredFiles; ++i) {
+        fs::path directory = root / "node_modules" / ("package" + std::to_string(i / 50)) /
+                             (i % 2 ? "lib" : "dist");
+        if (i % 25 == 0) {
+            fs::create_directories(directory);
+        }
+        writeSyntheticFile(directory / ("module" + std::to_string(i) + ".js"), 64 + random() % 960, false, random);
+    }
+    const size_t visibleFiles = 200;
+    fs::create_directories(root / "src");
+    for (size_t i = 0; i < visibleFiles; ++i) {
+        writeSyntheticFile(root / "src" / ("file" + std::to_string(i) + ".js"), 64 + random() % 960, false, random);
+    }
+    std::ofstream(root / ".gitignore") << "node_modules/\n";
+    gitOutput(root, {"init", "-q"});
+    
+    std::vector<ScenarioSample> samples;
+    std::vector<double> gitTimes;
+    for (int run = 0; run < runs; ++run) {
+        size_t listed = 0;
+        samples.push_back(runScenario([&]() {
+            TraceSpan span("list_files");
+            listed = listFiles(root.string()).size();
+        }, "", [&]() { return listed == visibleFiles + 1; }));
+        
+        auto gitStart = std::chrono::steady_clock::now();
+        size_t gitListed = splitRecords(gitOutput(root, {"ls-files", "-z", "--others", "--exclude-standard"})).size();
+        gitTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - gitStart).count());
+        samples.back().success = samples.back().success && gitListed == listed;
+    }
+    std::cout << ignoredFiles << " ignored files under node_modules/: listed in " << samples.back().totalMs
+              << " ms, git ls-files " << gitTimes.back() << " ms" << (samples.back().success ? "" : " (FAILED)")
+              << std::endl;
+    std::error_code ec;
+    fs::remove_all(root, ec);
+    std::string json = scenarioJson("list_ignored_tree", samples);
+    return "{\"ignored_files\": " + std::to_string(ignoredFiles) + ", \"visible_files\": " +
+           std::to_string(visibleFiles + 1) + ", \"git_ls_files_median_ms\": " + std::to_string(median(gitTimes)) +
+           ", " + json.substr(1);
+}
+
+bool parseBenchmarkArguments(int argc, char* argv[], BenchmarkOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--sizes" && i + 1 < argc) {
+            options.sizes.clear();
+            std::stringstream list(argv[++i]);
+            std::string size;
+            while (std::getline(list, size, ',')) {
+                options.sizes.push_back(std::stoul(size));
+            }
+        } else if (arg == "--runs" && i + 1 < argc) {
+            options.runs = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--output" && i + 1 < argc) {
+            options.outputPath = argv[++i];
+        } else if (arg == "--work-dir" && i + 1 < argc) {
+            options.workDir = argv[++i];
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "--keep") {
+            options.keepWorkDir = true;
+        } else if (arg == "--api-repos" && i + 1 < argc) {
+            options.apiRepos = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--api-limit" && i + 1 < argc) {
+            options.apiLimit = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--api-window" && i + 1 < argc) {
+            options.apiWindowSeconds = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--api-writes" && i + 1 < argc) {
+            options.apiWritesPerSecond = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--ignored-files" && i + 1 < argc) {
+            options.ignoredFiles = std::stoul(argv[++i]);
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--sizes 1000,10000,100000] [--runs N] [--output FILE]"
+                      << " [--work-dir DIR] [--seed N] [--keep] [--api-repos N] [--api-limit N]"
+                      << " [--api-window S] [--api-writes N] [--ignored-files N]" << std::endl;
+            return false;
+        }
+    }
+    return !options.sizes.empty();
+}
+
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    if (!parseBenchmarkArguments(argc, argv, options)) {
+        return 2;
+    }
+    std::string outputPath = fs::absolute(options.outputPath).string();
+    
+    // Identify the build being measured before the environment is replaced
+    fs::path sourceDir = fs::absolute(__FILE__).parent_path();
+    std::string sourceCommit = trimOutput(executeCommand({"git", "-C", sourceDir.string(), "describe", "--always",
+                                                         "--dirty", "--abbrev=40"}));
+    std::string gitVersion = trimOutput(executeCommand({"git", "--version"}));
+    
+    fs::path sandbox = options.workDir.empty()
+        ? fs::temp_directory_path() / ("github_automation_bench_" + std::to_string(getpid()))
+        : fs::absolute(options.workDir);
+    fs::remove_all(sandbox);
+    if (!installStandIns(sandbox)) {
+        std::cout << "Failed to set up the gh stand-in in " << sandbox << std::endl;
+        return 1;
+    }
+    
+    // Writes start far above the mock's secondary limit, so the bulk scenario
+    // measures how the scheduler backs off and ramps up again
+    setenv("GITHUB_AUTOMATION_API_WRITE_RATE", "50", 1);
+    
+    tracingEnabled = true;
+    getGitHubIdentity(true);  // Steady state: the identity is cached, as in day-to-day use
+    
+    std::vector<std::string> scenarioResults;
+    scenarioResults.push_back(runIgnoreCheck(sandbox, options.seed));
+    scenarioResults.push_back(runIndexCheck(sandbox, options.seed));
+    scenarioResults.push_back(runSessionRefreshCheck(sandbox));
+    scenarioResults.push_back(runCreateCheck(sandbox, options.seed));
+    scenarioResults.push_back(runLfsCheck(sandbox, options.seed));
+    scenarioResults.push_back(runPartialCloneCheck(sandbox, options.seed));
+    scenarioResults.push_back(runResumeCheck(sandbox, options.seed));
+    scenarioResults.push_back(runScanRulesCheck(sandbox, options.seed));
+    if (options.ignoredFiles > 0) {
+        scenarioResults.push_back(runIgnoredTreeScenario(sandbox, options.ignoredFiles, options.runs, options.seed));
+    }
+    for (size_t size : options.sizes) {
+        std::vector<ScenarioSample> createSamples;
+        std::vector<ScenarioSample> updateSamples;
+        std::vector<ScenarioSample> remoteUpdateSamples;
+        std::vector<ScenarioSample> chunkedSamples;
+        SyntheticTreeStats stats;
+        for (int run = 0; run < options.runs; ++run) {
+            std::string repoName = "bench-" + std::to_string(size) + "-" + std::to_string(run);
+            fs::path project = sandbox / "work" / repoName;
+            fs::path remote = sandbox / "remotes" / "bench" / (repoName + ".git");
+            stats = generateSyntheticTree(project, size, options.seed + static_cast<unsigned>(size));
+            // Left out by the pre-stage content scanner, so the remote holds just the generated files
+            std::ofstream(project / ".env") << "API_KEY=benchmark\n";
+            
+            // Name, description, private, path, select files, commit message
+            std::string createAnswers = repoName + "\nbenchmark\ny\n" + project.string() + "\nn\nInitial upload\n";
+            createSamples.push_back(runScenario(createProject, createAnswers, [&]() {
+                ProcessResult result;
+                runProcess({"git", "--git-dir", remote.string(), "ls-tree", "-r", "--name-only", "main"}, result);
+                return static_cast<size_t>(std::count(result.out.begin(), result.out.end(), '\n')) == stats.files;
+            }));
+            
+            mutateSyntheticTree(project, options.seed + static_cast<unsigned>(size) + 1);
+            
+            // Name, path, "add new and update existing", no selection, commit message
+            std::string updateAnswers = repoName + "\n" + project.string() + "\n3\nn\nBenchmark update\n";
+            updateSamples.push_back(runScenario(enhancedUpdateProject, updateAnswers, [&]() {
+                ProcessResult result;
+                runProcess({"git", "--git-dir", remote.string(), "log", "-1", "--format=%s", "main"}, result);
+                return trimOutput(result.out) == "Benchmark update";
+            }));
+            
+            // A handful of files applied through a partial, sparse clone of the remote
+            fs::path patch = sandbox / "work" / (repoName + "-patch");
+            std::mt19937 patchRandom(options.seed + static_cast<unsigned>(run));
+            fs::create_directories(patch / "patch");
+            for (int i = 0; i < 5; ++i) {
+                writeSyntheticFile(patch / "patch" / ("file" + std::to_string(i) + ".txt"), 2048, false, patchRandom);
+            }
+            RemoteUpdateOptions remoteUpdate;
+            remoteUpdate.repository = repoName;
+            remoteUpdate.sourcePath = patch.string();
+            remoteUpdate.commitMessage = "Benchmark remote update";
+            remoteUpdateSamples.push_back(runScenario([&]() { runRemoteUpdate(remoteUpdate); }, "", [&]() {
+                ProcessResult result;
+                runProcess({"git", "--git-dir", remote.string(), "log", "-1", "--format=%s", "main"}, result);
+                return trimOutput(result.out) == "Benchmark remote update";
+            }));
+            
+            // The same tree into a remote that refuses pushes of half its size:
+            // uploaded as commits of a quarter of its size, pushed one after another
+            fs::path chunkedProject = sandbox / "work" / (repoName + "-chunked");
+            fs::path chunkedRemote = sandbox / "remotes" / "bench" / (repoName + "-chunked.git");
+            generateSyntheticTree(chunkedProject, size, options.seed + static_cast<unsigned>(size));
+            setenv("BENCH_RECEIVE_LIMIT", std::to_string(stats.bytes / 2).c_str(), 1);
+            uploadChunkBytes = static_cast<long long>(stats.bytes / 4);
+            std::string chunkedAnswers = repoName + "-chunked\nbenchmark\ny\n" + chunkedProject.string() +
+                                         "\nn\nChunked upload\n";
+            chunkedSamples.push_back(runScenario(createProject, chunkedAnswers, [&]() {
+                ProcessResult result;
+                runProcess({"git", "--git-dir", chunkedRemote.string(), "rev-list", "--count", "main"}, result);
+                size_t commits = std::strtoul(result.out.c_str(), nullptr, 10);
+                runProcess({"git", "--git-dir", chunkedRemote.string(), "ls-tree", "-r", "--name-only", "main"}, result);
+                return commits >= 4 &&
+                       static_cast<size_t>(std::count(result.out.begin(), result.out.end(), '\n')) == stats.files;
+            }));
+            uploadChunkBytes = -1;
+            unsetenv("BENCH_RECEIVE_LIMIT");
+            
+            std::cout << size << " files, run " << run + 1 << "/" << options.runs
+                      << ": create " << createSamples.back().totalMs << " ms"
+                      << (createSamples.back().success ? "" : " (FAILED)")
+                      << ", update " << updateSamples.back().totalMs << " ms"
+                      << (updateSamples.back().success ? "" : " (FAILED)")
+                      << ", remote update " << remoteUpdateSamples.back().totalMs << " ms"
+                      << (remoteUpdateSamples.back().success ? "" : " (FAILED)")
+                      << ", chunked create " << chunkedSamples.back().totalMs << " ms"
+                      << (chunkedSamples.back().success ? "" : " (FAILED)") << std::endl;
+            
+            std::error_code ec;
+            fs::remove_all(chunkedProject, ec);
+            fs::remove_all(chunkedRemote, ec);
+            fs::remove_all(patch, ec);
+            fs::remove_all(project, ec);
+            fs::remove_all(remote, ec);
+        }
+        
+        std::string treeJson = "\"files\": " + std::to_string(stats.files) +
+                               ", \"directories\": " + std::to_string(stats.directories) +
+                               ", \"binary_files\": " + std::to_string(stats.binaryFiles) +
+                               ", \"bytes\": " + std::to_string(stats.bytes) + ", ";
+        for (auto scenario : {std::make_pair("create", &createSamples), std::make_pair("update", &updateSamples),
+                              std::make_pair("remote_update", &remoteUpdateSamples),
+                              std::make_pair("chunked_create", &chunkedSamples)}) {
+            std::string json = scenarioJson(scenario.first, *scenario.second);
+            scenarioResults.push_back("{" + treeJson + json.substr(1));
+        }
+    }
+    
+    // Bulk repository creation from several threads through the REST client,
+    // against a mock API that enforces primary and secondary limits
+    if (options.apiRepos > 0) {
+        std::vector<ScenarioSample> bulkSamples;
+        size_t primaryRejections = 0;
+        size_t secondaryRejections = 0;
+        for (int run = 0; run < options.runs; ++run) {
+            MockGitHubApi mockApi(options.apiLimit, options.apiWindowSeconds, options.apiWritesPerSecond);
+            if (!mockApi.start()) {
+                std::cout << "Failed to start the mock GitHub API" << std::endl;
+                return 1;
+            }
+            setenv("GITHUB_AUTOMATION_API_URL", mockApi.url().c_str(), 1);
+            setenv("GH_TOKEN", "benchmark", 1);
+            githubApi.forgetToken();
+            
+            bulkSamples.push_back(runScenario([&]() {
+                std::atomic<int> next{0};
+                std::vector<std::thread> creators;
+                for (int i = 0; i < 8; ++i) {
+                    creators.emplace_back([&]() {
+                        for (int index = next++; index < options.apiRepos; index = next++) {
+                            createRemoteRepository("bulk-" + std::to_string(run) + "-" + std::to_string(index), "", true);
+                        }
+                    });
+                }
+                for (auto& creator : creators) {
+                    creator.join();
+                }
+            }, "", [&]() { return mockApi.created() == static_cast<size_t>(options.apiRepos); }));
+            primaryRejections += mockApi.primaryRejections();
+            secondaryRejections += mockApi.secondaryRejections();
+            
+            std::cout << options.apiRepos << " repositories through the mock API, run " << run + 1 << "/"
+                      << options.runs << ": " << bulkSamples.back().totalMs << " ms, "
+                      << mockApi.primaryRejections() << " primary and " << mockApi.secondaryRejections()
+                      << " secondary limit responses" << (bulkSamples.back().success ? "" : " (FAILED)") << std::endl;
+            if (run == 0) {
+                scenarioResults.push_back(runOwnerCheck(mockApi, sandbox));
+            }
+            unsetenv("GITHUB_AUTOMATION_API_URL");
+            unsetenv("GH_TOKEN");
+            githubApi.forgetToken();
+        }
+        std::string json = scenarioJson("bulk_create", bulkSamples);
+        scenarioResults.push_back("{\"repositories\": " + std::to_string(options.apiRepos) +
+                                  ", \"api_limit\": " + std::to_string(options.apiLimit) +
+                                  ", \"api_window_s\": " + std::to_string(options.apiWindowSeconds) +
+                                  ", \"api_writes_per_s\": " + std::to_string(options.apiWritesPerSecond) +
+                                  ", \"primary_limit_responses\": " + std::to_string(primaryRejections) +
+                                  ", \"secondary_limit_responses\": " + std::to_string(secondaryRejections) +
+                                  ", " + json.substr(1));
+    }
+    
+    if (!options.keepWorkDir) {
+        std::error_code ec;
+        fs::remove_all(sandbox, ec);
+    }
+    
+    std::ofstream out(outputPath);
+    out << "{\n";
+    out << "  \"source_commit\": " << jsonEscape(sourceCommit) << ",\n";
+    out << "  \"git_version\": " << jsonEscape(gitVersion) << ",\n";
+    out << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+    out << "  \"seed\": " << options.seed << ",\n";
+    out << "  \"runs\": " << options.runs << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < scenarioResults.size(); ++i) {
+        out << "    " << scenarioResults[i] << (i + 1 < scenarioResults.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    std::cout << "Results written to " << outputPath << std::endl;
+    
+    bool allSucceeded = true;
+    for (const auto& result : scenarioResults) {
+        allSucceeded = allSucceeded && result.find("\"failures\": 0,") != std::string::npos;
+    }
+    return allSucceeded ? 0 : 1;
+}
+#endif
@@ -5,11 +5,27 @@ echo "Компиляция GitHub Автоматизатора..."
 # Проверяем наличие g++
 if command -v g++ &> /dev/null; then
     echo "Компиляция с использованием g++..."
-    g++ -std=c++17 main.cpp -o github_automation
+    # Необязательные библиотеки: OpenSSL для HTTPS-клиента GitHub API
+    LIB_FLAGS=""
+    if [ -f /usr/include/openssl/ssl.h ] || pkg-config --exists openssl 2>/dev/null; then
+        LIB_FLAGS="-DHAVE_OPENSSL -lssl -lcrypto"
+    fi
+    # и zlib для сжатия объектов первого коммита
+    if [ -f /usr/include/zlib.h ] || pkg-config --exists zlib 2>/dev/null; then
+        LIB_FLAGS="$LIB_FLAGS -DHAVE_ZLIB -lz"
+    fi
+    if [ "$1" == "benchmark" ]; then
+        echo "Режим: бенчмарк"
+        OUT_FILE=github_automation_benchmark
+        g++ -std=c++17 -O2 -pthread benchmark.cpp -o $OUT_FILE $LIB_FLAGS
+    else
+        OUT_FILE=github_automation
+        g++ -std=c++17 -pthread main.cpp -o $OUT_FILE $LIB_FLAGS
+    fi
     
     if [ $? -eq 0 ]; then
         echo "Компиляция успешно завершена!"
-        chmod +x github_automation
+        chmod +x $OUT_FILE
     else
         echo "Ошибка компиляции"
         exit 1